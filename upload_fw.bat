@@ -2,13 +2,24 @@
 SETLOCAL EnableDelayedExpansion
 
 REM Argument processing
+REM   --no_boot    do not load the bootloader
+REM   --no_flash   do not load the main firmware
+REM   --skip_same  do not load images that already match the target.
+REM                Resets the target and runs the installed firmware
+REM                for about 1 s before halting it to read memory.
 SET SKIP_BOOT=0
 SET SKIP_FLASH=0
+SET SKIP_SAME=0
+SET "BOOT_SKIP_REASON=--no_boot specified"
+SET "FLASH_SKIP_REASON=--no_flash specified"
+SET "BOOT_RESULT="
+SET "FLASH_RESULT="
 
 :CHECK_ARGS
 IF "%~1"=="" GOTO ARGS_DONE
 IF /I "%~1"=="--no_boot" SET SKIP_BOOT=1
 IF /I "%~1"=="--no_flash" SET SKIP_FLASH=1
+IF /I "%~1"=="--skip_same" SET SKIP_SAME=1
 SHIFT
 GOTO CHECK_ARGS
 :ARGS_DONE
@@ -83,6 +94,37 @@ IF %SKIP_FLASH% EQU 0 (
     ECHO [INFO] Firmware FLASH version: !FLASH_MAX_VERSION!
 )
 
+REM --------------------------------------------------
+REM Skip images already present on target (--skip_same)
+REM --------------------------------------------------
+IF %SKIP_SAME% EQU 1 (
+    ECHO [STATUS] Comparing firmware with target memory...
+    SET "SAME_CHECKS="
+    IF %SKIP_BOOT% EQU 0 (
+        SET "BOOT_RESULT=unreadable"
+        SET "SAME_CHECKS=!SAME_CHECKS!; same_check BOOT 0x01000000 {%FIRMWARE_DIR%\%FILE1%}"
+    )
+    IF %SKIP_FLASH% EQU 0 (
+        SET "FLASH_RESULT=unreadable"
+        SET "SAME_CHECKS=!SAME_CHECKS!; same_check FLASH 0x80000000 {!FILE2!}"
+    )
+    CALL :COMPARE_WITH_TARGET
+)
+
+IF "%BOOT_RESULT%"=="match" (
+    SET SKIP_BOOT=1
+    SET "BOOT_SKIP_REASON=identical image already on target"
+)
+IF "%BOOT_RESULT%"=="differs" ECHO [INFO] Bootloader on target differs, flashing
+IF "%BOOT_RESULT%"=="unreadable" ECHO [INFO] Could not read bootloader from target EEPROM, flashing
+
+IF "%FLASH_RESULT%"=="match" (
+    SET SKIP_FLASH=1
+    SET "FLASH_SKIP_REASON=identical image already on target"
+)
+IF "%FLASH_RESULT%"=="differs" ECHO [INFO] Main firmware on target differs, flashing
+IF "%FLASH_RESULT%"=="unreadable" ECHO [INFO] Could not read main firmware from target SPIFI, flashing
+
 REM Empty line
 ECHO.
 
@@ -98,12 +140,12 @@ IF %SKIP_BOOT% EQU 0 (
         --openocd-target "%OPENOCD_TARGET%" ^
         --boot-mode eeprom
     
-    IF %ERRORLEVEL% NEQ 0 (
+    IF !ERRORLEVEL! NEQ 0 (
         ECHO [ERROR] Failed to load bootloader
         EXIT /B 1
     )
 ) ELSE (
-    ECHO [INFO] Skipping bootloader (--no_boot specified^)
+    ECHO [INFO] Skipping bootloader (!BOOT_SKIP_REASON!^)
 )
 
 REM Empty line
@@ -121,13 +163,36 @@ IF %SKIP_FLASH% EQU 0 (
         --openocd-target "%OPENOCD_TARGET%" ^
         --boot-mode spifi
     
-    IF %ERRORLEVEL% NEQ 0 (
+    IF !ERRORLEVEL! NEQ 0 (
         ECHO [ERROR] Failed to load main firmware
         EXIT /B 1
     )
 ) ELSE (
-    ECHO [INFO] Skipping main firmware (--no_flash specified^)
+    ECHO [INFO] Skipping main firmware (!FLASH_SKIP_REASON!^)
 )
 
 ECHO [SUCCESS] Firmware upload completed successfully
-EXIT /B 0
\ No newline at end of file
+EXIT /B 0
+
+REM --------------------------------------------------
+REM COMPARE_WITH_TARGET
+REM Runs the same_check calls from SAME_CHECKS in one OpenOCD session.
+REM The installed firmware runs for 1 s first so that the kosvt
+REM bootloader can switch SPIFI to memory-mapped (XIP) mode. This timing
+REM has not been checked on hardware. If SPIFI is not mapped by then,
+REM the main firmware is reported as unreadable and flashed.
+REM Each check prints "SKIP_SAME <BOOT|FLASH> <match|differs|unreadable>",
+REM which sets BOOT_RESULT / FLASH_RESULT. The core is resumed afterwards.
+REM --------------------------------------------------
+:COMPARE_WITH_TARGET
+SET "SAME_LOG=%TEMP%\upload_fw_skip_same_%RANDOM%.log"
+"%OPENOCD_EXEC%" ^
+    -f "%OPENOCD_INTERFACE%" ^
+    -f "%OPENOCD_TARGET%" ^
+    -c "proc same_check {name addr file} { if {[catch {mdw $addr}]} { set r unreadable } elseif {[catch {verify_image $file}]} { set r differs } else { set r match }; echo [list SKIP_SAME $name $r] }" ^
+    -c "reset run; sleep 1000; halt%SAME_CHECKS%; resume; shutdown" >"%SAME_LOG%" 2>&1
+FOR /F "usebackq tokens=1-3" %%A IN ("%SAME_LOG%") DO (
+    IF "%%A"=="SKIP_SAME" SET "%%B_RESULT=%%C"
+)
+DEL "%SAME_LOG%" >NUL 2>&1
+EXIT /B 0